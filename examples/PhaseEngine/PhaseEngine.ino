@@ -0,0 +1,54 @@
+/* Demonstrate Multi_Timer_V2 phase engine function
+
+Operation and expected result:
+- Connect LEDs to pins D8 through D13 (PORTB on an UNO/NANO)
+with appropriate current limiting resistors.
+
+       LED    R1
+ D8  --->|---/\/\--- GND
+  .
+  .
+ D13 --->|---/\/\--- GND
+
+Connect input D4 to GND with either a SPST switch or breadboard
+jumper.
+
+One PhaseEngine replaces six FlasherTimers.  The six LEDs share
+a one second period.  Each is on for 250 milliseconds, started
+a sixth of a period after the one before, so the lit LEDs chase
+along the row.  All six outputs are written to PORTB at once.
+
+Closing switch1 lengthens the first LED's ON time to 700
+milliseconds without disturbing the others.
+*/
+
+#include <Multi_Timer_V2.h>
+
+PhaseEngine<6> chaser(1000);
+
+byte switch1 = 4;
+bool longDuty = false;
+
+void setup() {
+  DDRB |= 0x3F;  // D8 - D13 outputs
+  pinMode(switch1, INPUT_PULLUP);
+
+  for (uint8_t ch = 0; ch < 6; ch++) {
+    chaser.setChannel(ch, 250, ch * 1000UL / 6);
+  }
+  chaser.setEnable(true);
+}
+
+void loop() {
+  chaser.update();  // refresh the channel states
+
+  // Write all six channels in one go
+  PORTB = (PORTB & 0xC0) | (chaser.getStates() & 0x3F);
+
+  // Runtime duty change, only when the switch changes
+  bool closed = (digitalRead(switch1) == LOW);
+  if (closed != longDuty) {
+    longDuty = closed;
+    chaser.setDuty(0, longDuty ? 700 : 250);
+  }
+}
@@ -0,0 +1,57 @@
+#include <Multi_Timer_V2.h>
+
+/* Demonstrate Multi_Timer_V2 totalizer timer function
+
+Operation and expected result:
+
+Connect input D4 to GND with either a SPST switch or breadboard
+jumper.  Do the same for D2.
+
+- Start the IDE serial monitor. Insure baud rates between
+processor and monitor match.
+
+A totalizer works like a retentive timer but counts in seconds,
+minutes or hours instead of milliseconds, so it can run for far
+longer than 49.7 days - a run-hour meter, say.  To keep the demo
+short this one counts seconds.  For a meter counting to 20000
+hours use:
+
+  TotalizerTimer runHours(20000, TotalizerTimer::HOURS);
+
+While D4 (switch1) is closed the timer totals time.  When switch1
+is open the total is held.  Each whole second is shown on the
+serial monitor and the built-in LED lights when the preset is
+reached.  Closing D2 (resetSwitch) clears the total.
+*/
+
+TotalizerTimer runSeconds(30, TotalizerTimer::SECONDS);
+
+unsigned long lastCount = 0;
+
+byte switch1 = 4;
+byte resetSwitch = 2;
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(LED_BUILTIN, OUTPUT);
+  pinMode(switch1, INPUT_PULLUP);
+  pinMode(resetSwitch, INPUT_PULLUP);
+}
+
+void loop() {
+  runSeconds.update();  // refresh the timer value and flags
+
+  // Total time only while switch1 is closed
+  runSeconds.setEnable(digitalRead(switch1) == HIGH ? false : true);
+
+  runSeconds.setReset(digitalRead(resetSwitch) == HIGH ? false : true);
+
+  // This is the timer output
+  digitalWrite(LED_BUILTIN, runSeconds.isDone() ? HIGH : LOW);
+
+  // Show the total each time it changes
+  if (runSeconds.getCount() != lastCount) {
+    lastCount = runSeconds.getCount();
+    Serial.println(lastCount);
+  }
+}
@@ -0,0 +1,17 @@
+// filename: Arduino.cpp  (host shim)
+//
+// Virtual clock and Serial for host builds of Multi_Timer_V2.
+
+#include "Arduino.h"
+
+static uint32_t hostMillis = 0;
+
+HostSerial Serial;
+
+unsigned long millis() {
+  return hostMillis;
+}
+
+void hostSetMillis(uint32_t ms) {
+  hostMillis = ms;
+}
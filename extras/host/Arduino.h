@@ -0,0 +1,71 @@
+/* filename: Arduino.h  (host shim)
+
+Just enough of the Arduino core to build Multi_Timer_V2 on a PC.
+millis() reads a virtual clock which only moves when the host
+code moves it, so timers can be driven by a script instead of
+by wall-clock time.
+
+Not used by the Arduino IDE - the 'extras' folder is never
+compiled for a board.
+*/
+
+#ifndef MULTI_TIMER_HOST_ARDUINO_H
+#define MULTI_TIMER_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <iostream>
+
+// Host builds get Multi_Timer::timeToNextEvent() and friends,
+// which TimerSimulator and TimerEquivalence rely on.  Every file
+// of the build includes this, so library and callers agree on the
+// timers' vtables - the reason a sketch must never define it.
+#ifndef MULTI_TIMER_EVENTS
+#define MULTI_TIMER_EVENTS
+#endif
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+
+// System clock ticks - returns the virtual clock.  32 bits, as on
+// an AVR, so it rolls over after 49.7 days whatever the width of
+// the host's unsigned long.
+unsigned long millis();
+
+// Set the virtual clock returned by millis()
+void hostSetMillis(uint32_t);
+
+// Serial monitor stand-in which writes to stdout.  Output is
+// dropped between end() and the next begin().
+class HostSerial {
+public:
+  void begin(unsigned long) {
+    _Open = true;
+  }
+
+  void end() {
+    _Open = false;
+  }
+
+  template <typename T>
+  void print(const T &val) {
+    if (_Open) std::cout << val;
+  }
+
+  template <typename T>
+  void println(const T &val) {
+    if (_Open) std::cout << val << '\n';
+  }
+
+  void println() {
+    if (_Open) std::cout << '\n';
+  }
+
+private:
+  bool _Open = true;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,61 @@
+/* filename: CheckEquivalence.cpp  (host only)
+
+Run the differential equivalence harness on the event skipping
+candidate: randomized input streams against every reference timer
+type, then throughput of both side by side.  The candidate is
+accepted only if no divergence was found and, for every type, it
+makes at most 1/WORK_RATIO of the reference's update() calls over
+the same script.  Update counts don't change from run to run, so
+neither does the verdict; the timings are printed for information.
+Exit status is zero when accepted.
+
+Build and run from the library folder:
+  g++ -O2 -I extras/host -I src src/Multi_Timer_v2.cpp extras/host/Arduino.cpp
+      extras/host/TimerEquivalence.cpp extras/host/CheckEquivalence.cpp
+  ./a.out [seed]
+
+To check another engine, implement CandidateEngine and pass its
+factory in place of EventSkipEngine::make.
+*/
+
+#include "TimerEquivalence.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+const uint64_t WORK_RATIO = 10;  // candidate must do a tenth of the updates
+
+int main(int argc, char *argv[]) {
+  unsigned long seed = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 1;
+  CandidateFactory candidate = EventSkipEngine::make;
+
+  Serial.end();  // quiet the OnDelayTimer destructor
+
+  printf("Equivalence, seed %lu\n", seed);
+  bool same = checkEquivalence(candidate, seed, 200, 5000);
+  printf("  %s\n\n", same ? "no divergence found" : "DIVERGED");
+
+  printf("Throughput, timer updates per second and update() calls made\n");
+  printf("  %-20s %12s %12s %7s %11s %11s %7s\n", "type", "reference",
+         "candidate", "ratio", "ref calls", "cand calls", "ratio");
+  bool cheaper = true;
+  for (int k = 0; k < TIMER_KINDS; k++) {
+    double refRate, candRate;
+    uint64_t refUpdates, candUpdates;
+    compareThroughput(candidate, (TimerKind)k, 64, 100000, refRate, candRate,
+                      refUpdates, candUpdates);
+    printf("  %-20s %12.0f %12.0f %6.2fx %11llu %11llu %6.1fx\n",
+           timerKindName((TimerKind)k), refRate, candRate, candRate / refRate,
+           (unsigned long long)refUpdates, (unsigned long long)candUpdates,
+           (double)refUpdates / (candUpdates ? candUpdates : 1));
+    cheaper = cheaper and candUpdates * WORK_RATIO <= refUpdates;
+  }
+
+  bool accept = same and cheaper;
+  const char *verdict = "ACCEPT - equivalent and does less work";
+  if (!same) {
+    verdict = "REJECT - not equivalent";
+  } else if (!accept) verdict = "REJECT - equivalent but saves too little work";
+  printf("\n%s\n", verdict);
+  return accept ? 0 : 1;
+}
@@ -0,0 +1,732 @@
+/* filename: CheckSimulator.cpp  (host only)
+
+Check that TimerSimulator gives the same results as a polled loop().
+
+Each trial builds a random chain of timers - random types, presets
+and scan interval, with inputs either scripted to change at random
+times or taken from other timers' flags - and runs the same loop
+body twice: once polled, every scan, and once under TimerSimulator.
+Then, for every scan the simulator performed, all timers must read
+back exactly as in the polled run, counts included.  On the scans
+it skipped, the polled run must show no change in any flag or in
+isFlashing(), nor in the count of a timer which last answered
+NO_EVENT.  A PhaseEngine gets the same treatment, its polled run
+first checked against a per-channel model.  A TotalizerTimer is
+then run the same way to 1300 hours, past 2^32 ms and a millis()
+rollover.  Exit status is zero
+when every trial matches.
+
+Build and run from the library folder:
+  g++ -O2 -I extras/host -I src src/Multi_Timer_v2.cpp extras/host/Arduino.cpp
+      extras/host/TimerSimulator.cpp extras/host/TimerEquivalence.cpp
+      extras/host/CheckSimulator.cpp
+  ./a.out [seed [trials]]
+*/
+
+#include "TimerSimulator.h"
+#include "TimerEquivalence.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Where one input of one timer comes from
+enum Source {
+  SCRIPT,       // level toggled at the scripted times
+  DONE_OF,      // another timer's isDone()
+  NOT_DONE_OF,  // ... inverted
+  ROSE_OF       // another timer's getDoneRose()
+};
+
+struct Signal {
+  Source source;
+  int from;                       // timer, for the chained sources
+  std::vector<uint32_t> toggles;  // scripted level changes, in order
+};
+
+struct TimerPlan {
+  TimerKind kind;
+  unsigned long pre;
+  unsigned long onTime;
+  Signal enable, reset, ctrl, start;
+};
+
+struct Scenario {
+  uint32_t scan;
+  uint32_t duration;
+  std::vector<TimerPlan> timers;
+};
+
+// What the loop body saw, scan by scan
+struct Trace {
+  std::vector<uint32_t> times;
+  std::vector<TimerSnapshot> snaps;  // timers.size() per scan
+  std::vector<bool> still;  // timeToNextEvent() said NO_EVENT, ditto
+};
+
+/*======================================
+
+    The loop body shared by both runs
+--------------------------------------*/
+
+static const Scenario *plan;
+static std::vector<Multi_Timer *> timers;
+static Trace *trace;
+static TimerSimulator *sim;  // nullptr when polled
+static uint32_t polledTime;
+
+static bool level(const Signal &sig, uint32_t t) {
+  switch (sig.source) {
+    case DONE_OF: return timers[sig.from]->isDone();
+    case NOT_DONE_OF: return !timers[sig.from]->isDone();
+    case ROSE_OF: return timers[sig.from]->getDoneRose();
+    default: {
+      size_t passed = std::upper_bound(sig.toggles.begin(), sig.toggles.end(), t)
+                      - sig.toggles.begin();
+      return passed & 1;
+    }
+  }
+}
+
+// Earliest scripted change after t, if any
+static void nextToggle(const Signal &sig, uint32_t t, uint32_t &soonest) {
+  if (sig.source != SCRIPT) return;
+  std::vector<uint32_t>::const_iterator it =
+    std::upper_bound(sig.toggles.begin(), sig.toggles.end(), t);
+  if (it != sig.toggles.end() and *it < soonest) soonest = *it;
+}
+
+static void scenarioLoop() {
+  uint32_t t = (sim != nullptr) ? sim->now() : polledTime;
+
+  // Read back first, as a sketch would before driving its inputs
+  trace->times.push_back(t);
+  for (size_t i = 0; i < timers.size(); i++) {
+    trace->snaps.push_back(readSnapshot(timers[i], plan->timers[i].kind));
+  }
+
+  std::vector<TimerInputs> in(timers.size());
+  uint32_t soonest = UINT32_MAX;
+  for (size_t i = 0; i < timers.size(); i++) {
+    const TimerPlan &p = plan->timers[i];
+    in[i].enable = level(p.enable, t);
+    in[i].reset = level(p.reset, t);
+    in[i].ctrl = level(p.ctrl, t);
+    in[i].start = level(p.start, t);
+    nextToggle(p.enable, t, soonest);
+    nextToggle(p.reset, t, soonest);
+    nextToggle(p.ctrl, t, soonest);
+    nextToggle(p.start, t, soonest);
+  }
+  // All flags are read before any input changes
+  for (size_t i = 0; i < timers.size(); i++) {
+    applyInputs(timers[i], plan->timers[i].kind, in[i]);
+  }
+  for (size_t i = 0; i < timers.size(); i++) {
+    trace->still.push_back(timers[i]->timeToNextEvent() == Multi_Timer::NO_EVENT);
+  }
+  if (sim != nullptr and soonest != UINT32_MAX) sim->wakeAt(soonest);
+}
+
+static void build(const Scenario &sc, Trace &out) {
+  plan = &sc;
+  trace = &out;
+  timers.clear();
+  for (size_t i = 0; i < sc.timers.size(); i++) {
+    const TimerPlan &p = sc.timers[i];
+    timers.push_back(makeReferenceTimer(p.kind, p.pre, p.onTime));
+  }
+}
+
+static void tearDown() {
+  for (size_t i = 0; i < timers.size(); i++) {
+    dropReferenceTimer(timers[i], plan->timers[i].kind);
+  }
+  timers.clear();
+}
+
+static void runPolled(const Scenario &sc, Trace &out) {
+  build(sc, out);
+  sim = nullptr;
+  for (uint32_t k = 0; k <= sc.duration / sc.scan; k++) {
+    polledTime = k * sc.scan;
+    hostSetMillis(polledTime);
+    Multi_Timer::updateAllTimers();
+    scenarioLoop();
+  }
+  tearDown();
+}
+
+static void runSimulated(const Scenario &sc, Trace &out) {
+  build(sc, out);
+  TimerSimulator simulator(sc.scan);
+  sim = &simulator;
+  simulator.run(sc.duration, scenarioLoop);
+  sim = nullptr;
+  tearDown();
+}
+
+/*======================================
+
+    Random scenarios
+--------------------------------------*/
+
+static unsigned long pick(unsigned long &state, unsigned long range) {
+  return nextRandom(state) % range;
+}
+
+// Level changes an average of 'gap' ms apart.  With 'pulse' set,
+// each change is undone again shortly after.
+static void script(unsigned long &state, Signal &sig, uint32_t duration,
+                   uint32_t gap, uint32_t pulse) {
+  sig.source = SCRIPT;
+  sig.from = 0;
+  sig.toggles.clear();
+  uint32_t t = 0;
+  while (true) {
+    t += 1 + pick(state, 2 * gap);
+    if (t > duration) break;
+    sig.toggles.push_back(t);
+    if (pulse != 0) {
+      t += 1 + pick(state, pulse);
+      sig.toggles.push_back(t);
+    }
+  }
+}
+
+static void chain(unsigned long &state, Signal &sig, int timerCount,
+                  Source source) {
+  sig.source = source;
+  sig.from = pick(state, timerCount);
+  sig.toggles.clear();
+}
+
+static Scenario makeScenario(unsigned long &state) {
+  static const uint32_t scans[] = { 1, 2, 3, 5, 7, 10, 25, 100 };
+  Scenario sc;
+  sc.scan = scans[pick(state, sizeof(scans) / sizeof(scans[0]))];
+  sc.duration = sc.scan * (2000 + pick(state, 18000));
+
+  int count = 1 + pick(state, 6);
+  sc.timers.resize(count);
+  for (int i = 0; i < count; i++) {
+    TimerPlan &p = sc.timers[i];
+    p.kind = (TimerKind)pick(state, TIMER_KINDS);
+    p.pre = 1 + pick(state, sc.scan * 200);
+    p.onTime = pick(state, p.pre + 1);
+
+    uint32_t gap = sc.scan * (20 + pick(state, 400));
+    if (pick(state, 10) < 6) {
+      script(state, p.enable, sc.duration, gap, 0);
+    } else {
+      chain(state, p.enable, count, pick(state, 2) ? DONE_OF : NOT_DONE_OF);
+    }
+    if (pick(state, 10) < 8) {
+      script(state, p.reset, sc.duration, gap * 4, sc.scan * 5);
+    } else {
+      chain(state, p.reset, count, DONE_OF);
+    }
+    if (pick(state, 10) < 6) {
+      script(state, p.ctrl, sc.duration, gap, 0);
+    } else {
+      chain(state, p.ctrl, count, DONE_OF);
+    }
+    if (pick(state, 2)) {
+      script(state, p.start, sc.duration, gap, sc.scan);
+    } else {
+      chain(state, p.start, count, ROSE_OF);
+    }
+  }
+  return sc;
+}
+
+/*======================================
+
+    Comparison
+--------------------------------------*/
+
+static bool sameFlags(const TimerSnapshot &a, const TimerSnapshot &b) {
+  return a.done == b.done and a.running == b.running
+         and a.doneRose == b.doneRose and a.doneFell == b.doneFell
+         and a.flashing == b.flashing;
+}
+
+static void report(const char *what, unsigned long trial, const Scenario &sc,
+                   uint32_t t, size_t timer, const TimerSnapshot &polled,
+                   const TimerSnapshot &simulated) {
+  printf("trial %lu: %s at %u ms, scan %u ms, timer %u of %u (%s)\n",
+         trial, what, t, sc.scan, (unsigned)timer, (unsigned)sc.timers.size(),
+         timerKindName(sc.timers[timer].kind));
+  printf("    polled    done %d running %d rose %d fell %d flashing %d count %lu\n",
+         polled.done, polled.running, polled.doneRose, polled.doneFell,
+         polled.flashing, polled.count);
+  printf("    simulated done %d running %d rose %d fell %d flashing %d count %lu\n",
+         simulated.done, simulated.running, simulated.doneRose,
+         simulated.doneFell, simulated.flashing, simulated.count);
+}
+
+static bool compare(unsigned long trial, const Scenario &sc,
+                    const Trace &polled, const Trace &simulated) {
+  size_t n = sc.timers.size();
+  size_t polledScans = polled.times.size();
+
+  for (size_t j = 0; j < simulated.times.size(); j++) {
+    size_t k = simulated.times[j] / sc.scan;
+    if (simulated.times[j] % sc.scan != 0 or k >= polledScans) {
+      printf("trial %lu: simulator scanned off the grid at %u ms\n",
+             trial, simulated.times[j]);
+      return false;
+    }
+    // Everything matches where the simulator scanned
+    for (size_t i = 0; i < n; i++) {
+      const TimerSnapshot &want = polled.snaps[k * n + i];
+      const TimerSnapshot &got = simulated.snaps[j * n + i];
+      if (!(want == got)) {
+        report("differs", trial, sc, simulated.times[j], i, want, got);
+        return false;
+      }
+    }
+    // ... and nothing a sketch reacts to changes where it didn't
+    size_t skipEnd = (j + 1 < simulated.times.size())
+                       ? simulated.times[j + 1] / sc.scan
+                       : polledScans;
+    for (size_t s = k + 1; s < skipEnd; s++) {
+      for (size_t i = 0; i < n; i++) {
+        const TimerSnapshot &held = simulated.snaps[j * n + i];
+        const TimerSnapshot &now = polled.snaps[s * n + i];
+        if (!sameFlags(held, now)) {
+          report("changes on a skipped scan", trial, sc, s * sc.scan, i, now, held);
+          return false;
+        }
+        // NO_EVENT holds the count as well
+        if (simulated.still[j * n + i] and held.count != now.count) {
+          report("counts after NO_EVENT", trial, sc, s * sc.scan, i, now, held);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/*======================================
+
+    Totalizer past 2^32 ms
+--------------------------------------*/
+
+// 1300 hours at a 1 s scan, with enable off for an hour and a half
+// on the way and a reset some hours after done.  Times are ms from
+// the first scan, in 64 bits - millis() rolls over near 1193 hours.
+static const uint64_t HOUR = TotalizerTimer::HOURS;
+static const uint64_t totalizerPauseFrom = 1000 * HOUR + 1234;
+static const uint64_t totalizerPauseTo = 1001 * HOUR + HOUR / 2 + 77;
+static const uint64_t totalizerResetAt = 1305 * HOUR;
+static const uint64_t totalizerEnd = 1306 * HOUR;
+
+static TotalizerTimer *totalizer;
+static uint64_t totalizerClock;
+static uint32_t totalizerLast;
+static TimerSnapshot totalizerSnap;
+static std::vector<uint64_t> totalizerTimes;  // simulated run only
+static std::vector<TimerSnapshot> totalizerSnaps;
+
+static void totalizerLoop() {
+  uint32_t t = (sim != nullptr) ? sim->now() : polledTime;
+  totalizerClock += (uint32_t)(t - totalizerLast);
+  totalizerLast = t;
+
+  totalizerSnap.done = totalizer->isDone();
+  totalizerSnap.running = totalizer->isRunning();
+  totalizerSnap.doneRose = totalizer->getDoneRose();
+  totalizerSnap.doneFell = totalizer->getDoneFell();
+  totalizerSnap.flashing = false;
+  totalizerSnap.count = totalizer->getCount();
+
+  uint64_t at = totalizerClock;
+  totalizer->setEnable(at < totalizerPauseFrom or at >= totalizerPauseTo);
+  totalizer->setReset(at >= totalizerResetAt and at < totalizerResetAt + 5000);
+
+  if (sim == nullptr) return;
+  totalizerTimes.push_back(at);
+  totalizerSnaps.push_back(totalizerSnap);
+  const uint64_t toggles[] = { totalizerPauseFrom, totalizerPauseTo,
+                               totalizerResetAt, totalizerResetAt + 5000 };
+  for (size_t i = 0; i < 4; i++) {
+    // wakeAt() reaches 2^31 ms ahead - later ones are asked for
+    // from a later scan
+    if (toggles[i] > at and toggles[i] - at < 0x80000000ULL) {
+      sim->wakeAt((uint32_t)toggles[i]);
+      break;
+    }
+  }
+}
+
+static void makeTotalizer() {
+  // Zeroed first, as a sketch's global would be
+  totalizer = new (calloc(1, sizeof(TotalizerTimer)))
+    TotalizerTimer(1300, TotalizerTimer::HOURS);
+  totalizerClock = 0;
+  totalizerLast = 0;
+}
+
+static void dropTotalizer() {
+  totalizer->~TotalizerTimer();
+  free(totalizer);
+}
+
+static void printTotalizer(const char *who, const TimerSnapshot &s) {
+  printf("    %-9s done %d running %d rose %d fell %d count %lu\n",
+         who, s.done, s.running, s.doneRose, s.doneFell, s.count);
+}
+
+static bool checkTotalizer() {
+  const uint32_t scan = 1000;
+
+  // Simulated first, in day-long runs since run() takes 32 bits
+  makeTotalizer();
+  totalizerTimes.clear();
+  totalizerSnaps.clear();
+  TimerSimulator simulator(scan);
+  sim = &simulator;
+  for (uint64_t done = 0; done < totalizerEnd; done += 24 * HOUR) {
+    uint64_t left = totalizerEnd - done;
+    simulator.run((uint32_t)(left < 24 * HOUR ? left : 24 * HOUR) - 1,
+                  totalizerLoop);
+  }
+  sim = nullptr;
+  dropTotalizer();
+
+  // Then polled, checked scan by scan against the simulated run
+  makeTotalizer();
+  size_t j = 0;
+  bool sawDone = false, same = true;
+  for (uint64_t at = 0; at < totalizerEnd and same; at += scan) {
+    polledTime = (uint32_t)at;
+    hostSetMillis(polledTime);
+    Multi_Timer::updateAllTimers();
+    totalizerLoop();
+    sawDone = sawDone or totalizerSnap.doneRose;
+
+    while (j < totalizerTimes.size() and totalizerTimes[j] < at) j++;
+    if (j < totalizerTimes.size() and totalizerTimes[j] == at) {
+      same = (totalizerSnap == totalizerSnaps[j]);
+      if (!same) {
+        printf("totalizer differs at %llu ms\n", (unsigned long long)at);
+        printTotalizer("simulated", totalizerSnaps[j]);
+      }
+    } else if (j > 0) {
+      same = sameFlags(totalizerSnap, totalizerSnaps[j - 1]);
+      if (!same) {
+        printf("totalizer changes on a skipped scan at %llu ms\n",
+               (unsigned long long)at);
+        printTotalizer("simulated", totalizerSnaps[j - 1]);
+      }
+    } else {
+      same = false;
+      printf("totalizer - simulator skipped the first scan\n");
+    }
+    if (!same) printTotalizer("polled", totalizerSnap);
+  }
+  dropTotalizer();
+
+  if (same and !sawDone) {
+    printf("totalizer never reached preset\n");
+    return false;
+  }
+  if (same) {
+    printf("totalizer to 1300 hours - simulator matches a polled run\n");
+    printf("  %llu scans performed of %llu polled\n",
+           (unsigned long long)totalizerTimes.size(),
+           (unsigned long long)(totalizerEnd / scan));
+  }
+  return same;
+}
+
+/*======================================
+
+    PhaseEngine against a model
+--------------------------------------*/
+
+// A PhaseEngine with random periods, channels, enable and reset,
+// and setChannel() / setDuty() calls at random times, running or
+// not.  The polled run is checked scan by scan against a model
+// which works each channel out from the time since start; the
+// simulated run is then checked against the polled one as above.
+
+static const uint8_t PHASE_CHANNELS = 12;
+typedef PhaseEngine<PHASE_CHANNELS> TestEngine;
+
+struct PhaseChange {
+  uint32_t at;
+  uint8_t channel;
+  bool keepPhase;  // setDuty() rather than setChannel()
+  unsigned long duty;
+  unsigned long phase;
+};
+
+struct PhasePlan {
+  uint32_t scan;
+  uint32_t duration;
+  unsigned long period;
+  Signal enable, reset;
+  std::vector<PhaseChange> changes;  // in time order
+};
+
+struct PhaseTrace {
+  std::vector<uint32_t> times;
+  std::vector<unsigned long> states;
+  std::vector<bool> rose;
+  std::vector<bool> running;
+  std::vector<unsigned long> held;  // states as the loop left them
+};
+
+static const PhasePlan *phasePlan;
+static TestEngine *engine;
+static PhaseTrace *phaseTrace;
+static size_t nextChange;
+
+static void phaseLoop() {
+  uint32_t t = (sim != nullptr) ? sim->now() : polledTime;
+
+  phaseTrace->times.push_back(t);
+  phaseTrace->states.push_back(engine->getStates());
+  phaseTrace->rose.push_back(engine->getDoneRose());
+  phaseTrace->running.push_back(engine->isRunning());
+
+  engine->setEnable(level(phasePlan->enable, t));
+  engine->setReset(level(phasePlan->reset, t));
+  const std::vector<PhaseChange> &changes = phasePlan->changes;
+  while (nextChange < changes.size() and changes[nextChange].at <= t) {
+    const PhaseChange &c = changes[nextChange++];
+    if (c.keepPhase) {
+      engine->setDuty(c.channel, c.duty);
+    } else engine->setChannel(c.channel, c.duty, c.phase);
+  }
+  // setChannel() shows at once - the skipped scans must match this
+  phaseTrace->held.push_back(engine->getStates());
+
+  if (sim == nullptr) return;
+  uint32_t soonest = UINT32_MAX;
+  nextToggle(phasePlan->enable, t, soonest);
+  nextToggle(phasePlan->reset, t, soonest);
+  if (nextChange < changes.size() and changes[nextChange].at < soonest) {
+    soonest = changes[nextChange].at;
+  }
+  if (soonest != UINT32_MAX) sim->wakeAt(soonest);
+}
+
+static void runPhase(const PhasePlan &pp, PhaseTrace &out, bool simulated) {
+  phasePlan = &pp;
+  phaseTrace = &out;
+  nextChange = 0;
+  // Zeroed first, as a sketch's global would be
+  engine = new (calloc(1, sizeof(TestEngine))) TestEngine(pp.period);
+
+  if (simulated) {
+    TimerSimulator simulator(pp.scan);
+    sim = &simulator;
+    simulator.run(pp.duration, phaseLoop);
+    sim = nullptr;
+  } else {
+    for (uint32_t k = 0; k <= pp.duration / pp.scan; k++) {
+      polledTime = k * pp.scan;
+      hostSetMillis(polledTime);
+      Multi_Timer::updateAllTimers();
+      phaseLoop();
+    }
+  }
+  engine->~TestEngine();
+  free(engine);
+}
+
+static PhaseChange randomChange(unsigned long &state, unsigned long period,
+                                uint32_t at, uint8_t channel) {
+  PhaseChange c;
+  c.at = at;
+  c.channel = channel;
+  c.keepPhase = (at != 0 and pick(state, 3) == 0);
+  unsigned long kind = pick(state, 10);
+  if (kind == 0) {
+    c.duty = 0;  // always off
+  } else if (kind == 1) {
+    c.duty = period + pick(state, 3);  // always on
+  } else c.duty = 1 + pick(state, period > 1 ? period - 1 : 1);
+  c.phase = pick(state, 2 * period);  // taken modulo the period
+  return c;
+}
+
+static PhasePlan makePhasePlan(unsigned long &state) {
+  static const uint32_t scans[] = { 1, 2, 3, 5, 7, 10, 25, 100 };
+  PhasePlan pp;
+  pp.scan = scans[pick(state, sizeof(scans) / sizeof(scans[0]))];
+  pp.duration = pp.scan * (1000 + pick(state, 5000));
+  // Now and then shorter than a scan, so whole periods are missed
+  pp.period = 1 + pick(state, pp.scan * (pick(state, 4) ? 60 : 2));
+
+  uint32_t gap = pp.scan * (50 + pick(state, 500));
+  script(state, pp.enable, pp.duration, gap, 0);
+  script(state, pp.reset, pp.duration, gap * 4, pp.scan * 5);
+
+  for (uint8_t ch = 0; ch < PHASE_CHANNELS; ch++) {
+    pp.changes.push_back(randomChange(state, pp.period, 0, ch));
+  }
+  uint32_t at = 0;
+  while (true) {
+    at += 1 + pick(state, gap);
+    if (at > pp.duration) break;
+    pp.changes.push_back(randomChange(state, pp.period, at,
+                                      pick(state, PHASE_CHANNELS)));
+  }
+  return pp;
+}
+
+static void reportPhase(const char *what, unsigned long trial,
+                        const PhasePlan &pp, uint32_t t,
+                        unsigned long want, bool wantRose, bool wantRunning,
+                        unsigned long got, bool gotRose, bool gotRunning) {
+  printf("phase trial %lu: %s at %u ms, scan %u ms, period %lu ms\n",
+         trial, what, t, pp.scan, pp.period);
+  printf("    expected states %03lx rose %d running %d\n",
+         want, wantRose, wantRunning);
+  printf("    got      states %03lx rose %d running %d\n",
+         got, gotRose, gotRunning);
+}
+
+// Replay the polled run: each update saw the inputs the previous
+// scan's loop left, and every channel follows from the time since
+// the engine started
+static bool checkPhaseModel(unsigned long trial, const PhasePlan &pp,
+                            const PhaseTrace &tr) {
+  unsigned long duty[PHASE_CHANNELS] = { 0 };
+  unsigned long onAt[PHASE_CHANNELS] = { 0 };
+  bool enable = false, reset = false, running = false;
+  uint32_t start = 0, period = 0;
+  size_t next = 0;
+
+  for (size_t k = 0; k < tr.times.size(); k++) {
+    uint32_t t = tr.times[k];
+    bool rose = false;
+    if (reset or !enable) {
+      running = false;
+    } else if (!running) {
+      running = true;
+      start = t;
+      period = 0;
+      rose = true;
+    } else {
+      uint32_t now = (t - start) / pp.period;
+      rose = (now != period);
+      period = now;
+    }
+    unsigned long want = 0;
+    if (running) {
+      unsigned long pos = (t - start) % pp.period;
+      for (uint8_t ch = 0; ch < PHASE_CHANNELS; ch++) {
+        bool on = (duty[ch] >= pp.period)
+                  or (duty[ch] != 0
+                      and (pos + pp.period - onAt[ch]) % pp.period < duty[ch]);
+        if (on) want |= 1UL << ch;
+      }
+    }
+    if (want != tr.states[k] or rose != tr.rose[k] or running != tr.running[k]) {
+      reportPhase("differs from the model", trial, pp, t, want, rose, running,
+                  tr.states[k], tr.rose[k], tr.running[k]);
+      return false;
+    }
+
+    enable = level(pp.enable, t);
+    reset = level(pp.reset, t);
+    for (; next < pp.changes.size() and pp.changes[next].at <= t; next++) {
+      const PhaseChange &c = pp.changes[next];
+      duty[c.channel] = c.duty;
+      if (!c.keepPhase) onAt[c.channel] = c.phase % pp.period;
+    }
+  }
+  return true;
+}
+
+static bool comparePhase(unsigned long trial, const PhasePlan &pp,
+                         const PhaseTrace &polled, const PhaseTrace &simulated) {
+  size_t polledScans = polled.times.size();
+  for (size_t j = 0; j < simulated.times.size(); j++) {
+    size_t k = simulated.times[j] / pp.scan;
+    if (simulated.times[j] % pp.scan != 0 or k >= polledScans) {
+      printf("phase trial %lu: simulator scanned off the grid at %u ms\n",
+             trial, simulated.times[j]);
+      return false;
+    }
+    // Where the simulator scanned and, held, on the scans it skipped
+    size_t skipEnd = (j + 1 < simulated.times.size())
+                       ? simulated.times[j + 1] / pp.scan
+                       : polledScans;
+    for (size_t s = k; s < skipEnd; s++) {
+      unsigned long states = (s == k) ? simulated.states[j] : simulated.held[j];
+      if (polled.states[s] != states or polled.rose[s] != simulated.rose[j]
+          or polled.running[s] != simulated.running[j]) {
+        reportPhase(s == k ? "simulator differs" : "changes on a skipped scan",
+                    trial, pp, polled.times[s], polled.states[s],
+                    polled.rose[s], polled.running[s], states,
+                    simulated.rose[j], simulated.running[j]);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool checkPhaseEngine(unsigned long seed, unsigned long trials) {
+  uint64_t performed = 0, polledTotal = 0;
+  for (unsigned long trial = 0; trial < trials; trial++) {
+    unsigned long state = (seed * 2654435761UL) ^ (trial + 0x5000);
+    if ((uint32_t)state == 0) state = 1;
+    PhasePlan pp = makePhasePlan(state);
+
+    PhaseTrace polled, simulated;
+    runPhase(pp, polled, false);
+    if (!checkPhaseModel(trial, pp, polled)) return false;
+    runPhase(pp, simulated, true);
+    if (!comparePhase(trial, pp, polled, simulated)) return false;
+    performed += simulated.times.size();
+    polledTotal += polled.times.size();
+  }
+  printf("seed %lu, %lu PhaseEngine trials - model and simulator match\n",
+         seed, trials);
+  printf("  %llu scans performed of %llu polled\n",
+         (unsigned long long)performed, (unsigned long long)polledTotal);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long seed = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 1;
+  unsigned long trials = (argc > 2) ? strtoul(argv[2], nullptr, 0) : 300;
+
+  Serial.end();  // quiet the OnDelayTimer destructor
+
+  uint64_t performed = 0, polledTotal = 0;
+  for (unsigned long trial = 0; trial < trials; trial++) {
+    unsigned long state = (seed * 2654435761UL) ^ (trial + 1);
+    if ((uint32_t)state == 0) state = 1;
+    Scenario sc = makeScenario(state);
+
+    Trace polled, simulated;
+    runPolled(sc, polled);
+    runSimulated(sc, simulated);
+    if (!compare(trial, sc, polled, simulated)) {
+      printf("seed %lu - simulator does not match a polled run\n", seed);
+      return 1;
+    }
+    performed += simulated.times.size();
+    polledTotal += polled.times.size();
+  }
+  printf("seed %lu, %lu trials - simulator matches a polled run\n", seed, trials);
+  printf("  %llu scans performed of %llu polled\n",
+         (unsigned long long)performed, (unsigned long long)polledTotal);
+
+  if (!checkPhaseEngine(seed, trials)) {
+    printf("seed %lu - PhaseEngine does not match\n", seed);
+    return 1;
+  }
+  return checkTotalizer() ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+/* filename: SimulateSequence.cpp  (host only)
+
+Demonstrate TimerSimulator on a sequence which takes over ten
+minutes of real time to run on a board.
+
+A pump runs for 4 minutes, stops for 2 minutes and then runs
+again.  A 10 minute retentive timer totals the pump run time and,
+when done, enables a 1.5 second on-delay alarm timer.  A pulse
+generator ticks once a minute while the pump runs.
+
+Build and run from the library folder:
+  g++ -I extras/host -I src src/Multi_Timer_v2.cpp extras/host/Arduino.cpp
+      extras/host/TimerSimulator.cpp extras/host/SimulateSequence.cpp
+  ./a.out
+*/
+
+#include "TimerSimulator.h"
+
+const unsigned long scanInterval = 1;  // a fast loop()
+
+RetentiveTimer pumpRunTimer(600000UL);  // 10 minutes
+OnDelayTimer alarmTimer(1500);
+PulseGenTimer minuteTicker(60000UL);
+
+TimerSimulator sim(scanInterval);
+
+int ticks = 0;
+
+// Scripted pump input - on, except from 4 to 6 minutes
+bool pumpRunning() {
+  return sim.now() < 240000UL or sim.now() >= 360000UL;
+}
+
+// Same body a sketch would have in loop(), less the update call
+void simLoop() {
+  // The pump only changes state at the script points
+  if (sim.now() < 240000UL) {
+    sim.wakeAt(240000UL);
+  } else if (sim.now() < 360000UL) {
+    sim.wakeAt(360000UL);
+  }
+
+  pumpRunTimer.setEnable(pumpRunning());
+  minuteTicker.setEnable(pumpRunning());
+  alarmTimer.setEnable(pumpRunTimer.isDone());
+
+  if (minuteTicker.getDoneRose()) {
+    Serial.print(sim.now());
+    Serial.print(" ms: tick ");
+    Serial.println(++ticks);
+  }
+  if (pumpRunTimer.getDoneRose()) {
+    Serial.print(sim.now());
+    Serial.println(" ms: pump run time reached");
+  }
+  if (alarmTimer.getDoneRose()) {
+    Serial.print(sim.now());
+    Serial.println(" ms: alarm");
+  }
+}
+
+int main() {
+  sim.run(15UL * 60000UL, simLoop);  // fifteen minutes
+
+  Serial.print("scans performed: ");
+  Serial.println(sim.getScans());
+  Serial.print("scans a polled loop() would make: ");
+  Serial.println(sim.getPolledScans());
+  return 0;
+}
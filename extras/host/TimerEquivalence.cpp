@@ -0,0 +1,429 @@
+// filename: TimerEquivalence.cpp  (host only)
+//
+// Differential equivalence harness for Multi_Timer_V2.
+// See TimerEquivalence.h.
+
+#include "TimerEquivalence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static const char *kindNames[TIMER_KINDS] = {
+  "OnDelayTimer", "OffDelayTimer", "RetentiveTimer", "PulseGenTimer",
+  "LatchedTimer", "RetriggerableTimer", "FlasherTimer", "TotalizerTimer"
+};
+
+const char *timerKindName(TimerKind kind) {
+  return kindNames[kind];
+}
+
+bool operator==(const TimerSnapshot &a, const TimerSnapshot &b) {
+  return a.done == b.done and a.running == b.running
+         and a.doneRose == b.doneRose and a.doneFell == b.doneFell
+         and a.flashing == b.flashing and a.count == b.count;
+}
+
+/*======================================
+
+    Reference timers
+--------------------------------------*/
+
+// The timers rely on a sketch's globals being zeroed - do the same
+template <class T>
+static Multi_Timer *zeroed(unsigned long pre) {
+  return new (calloc(1, sizeof(T))) T(pre);
+}
+
+template <class T>
+static void drop(Multi_Timer *timer) {
+  T *t = static_cast<T *>(timer);
+  t->~T();
+  free(t);
+}
+
+Multi_Timer *makeReferenceTimer(TimerKind kind, unsigned long pre,
+                                unsigned long onTime) {
+  switch (kind) {
+    case ON_DELAY: return zeroed<OnDelayTimer>(pre);
+    case OFF_DELAY: return zeroed<OffDelayTimer>(pre);
+    case RETENTIVE: return zeroed<RetentiveTimer>(pre);
+    case PULSE_GEN: return zeroed<PulseGenTimer>(pre);
+    case LATCHED: return zeroed<LatchedTimer>(pre);
+    case RETRIGGERABLE: return zeroed<RetriggerableTimer>(pre);
+    case TOTALIZER:
+      return new (calloc(1, sizeof(TotalizerTimer)))
+        TotalizerTimer(pre, TOTALIZER_UNIT);
+    default:
+      return new (calloc(1, sizeof(FlasherTimer))) FlasherTimer(pre, onTime);
+  }
+}
+
+void dropReferenceTimer(Multi_Timer *timer, TimerKind kind) {
+  switch (kind) {
+    case ON_DELAY: drop<OnDelayTimer>(timer); break;
+    case OFF_DELAY: drop<OffDelayTimer>(timer); break;
+    case RETENTIVE: drop<RetentiveTimer>(timer); break;
+    case PULSE_GEN: drop<PulseGenTimer>(timer); break;
+    case LATCHED: drop<LatchedTimer>(timer); break;
+    case RETRIGGERABLE: drop<RetriggerableTimer>(timer); break;
+    case TOTALIZER: drop<TotalizerTimer>(timer); break;
+    default: drop<FlasherTimer>(timer); break;
+  }
+}
+
+// What a sketch's loop() would do with the inputs.  A latched
+// timer is only started and reset - _Control is its latch, and
+// setEnable() / setCtrl() would override it.
+void applyInputs(Multi_Timer *timer, TimerKind kind, const TimerInputs &in) {
+  if (kind == LATCHED) {
+    timer->setReset(in.reset);
+    static_cast<LatchedTimer *>(timer)->Start(in.start);
+    return;
+  }
+  timer->setEnable(in.enable);
+  timer->setReset(in.reset);
+  timer->setCtrl(in.ctrl);
+}
+
+TimerSnapshot readSnapshot(Multi_Timer *timer, TimerKind kind) {
+  TimerSnapshot snap;
+  snap.done = timer->isDone();
+  snap.running = timer->isRunning();
+  snap.doneRose = timer->getDoneRose();
+  snap.doneFell = timer->getDoneFell();
+  snap.flashing = (kind == FLASHER)
+                    ? static_cast<FlasherTimer *>(timer)->isFlashing()
+                    : false;
+  snap.count = timer->getCount();
+  if (kind == TOTALIZER) {  // in ms, so the sub-counter is checked too
+    TotalizerTimer *t = static_cast<TotalizerTimer *>(timer);
+    snap.count = snap.count * TOTALIZER_UNIT + t->getSubCount();
+  }
+  return snap;
+}
+
+/*======================================
+
+    Scripted input streams
+--------------------------------------*/
+
+// xorshift32 - same stream for a given seed on any host
+unsigned long nextRandom(unsigned long &state) {
+  uint32_t x = (uint32_t)state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  state = x;
+  return x;
+}
+
+static bool chance(unsigned long &state, unsigned long oneIn) {
+  return nextRandom(state) % oneIn == 0;
+}
+
+// Inputs mostly hold for a while so timers get to preset
+static void nextInputs(unsigned long &state, TimerInputs &in) {
+  if (chance(state, 12)) in.enable = !in.enable;
+  if (chance(state, in.reset ? 3 : 40)) in.reset = !in.reset;
+  if (chance(state, 10)) in.ctrl = !in.ctrl;
+  in.start = chance(state, 25);
+}
+
+// Latched timer episodes - a single Start() pulse, then reset
+// raised before the timer can be done and held a random while,
+// often past preset.  The latch alone has to carry the timer on.
+struct LatchScript {
+  unsigned long pulseAt;
+  unsigned long resetFrom;
+  unsigned long resetTo;
+  bool pulsed;
+};
+
+static void nextLatchEpisode(unsigned long &state, LatchScript &ls,
+                             unsigned long now, unsigned long pre) {
+  ls.pulseAt = now + 1 + nextRandom(state) % pre;
+  ls.resetFrom = ls.pulseAt + nextRandom(state) % pre;
+  ls.resetTo = ls.resetFrom + 1 + nextRandom(state) % (2 * pre);
+  ls.pulsed = false;
+}
+
+static void nextLatchInputs(unsigned long &state, LatchScript &ls,
+                            unsigned long now, unsigned long pre,
+                            TimerInputs &in) {
+  if (now >= ls.resetTo) nextLatchEpisode(state, ls, now, pre);
+  in.start = (!ls.pulsed and now >= ls.pulseAt);
+  if (in.start) ls.pulsed = true;
+  in.reset = (now >= ls.resetFrom and now < ls.resetTo);
+}
+
+// Mostly short scans, the same millisecond now and then, and
+// the odd long stall
+static unsigned long nextGap(unsigned long &state, unsigned long pre) {
+  if (chance(state, 50)) return nextRandom(state) % (2 * pre + 1);
+  return nextRandom(state) % 6;
+}
+
+static void printSnapshot(const char *who, const TimerSnapshot &s) {
+  printf("    %-9s done %d running %d rose %d fell %d flashing %d count %lu\n",
+         who, s.done, s.running, s.doneRose, s.doneFell, s.flashing, s.count);
+}
+
+bool checkEquivalence(CandidateFactory factory, unsigned long seed,
+                      unsigned long trials, unsigned long scans) {
+  bool same = true;
+
+  for (int k = 0; k < TIMER_KINDS; k++) {
+    TimerKind kind = (TimerKind)k;
+    bool kindSame = true;
+
+    for (unsigned long trial = 0; trial < trials and kindSame; trial++) {
+      unsigned long state = (seed * 2654435761UL) ^ (k * 40503UL + trial + 1);
+      if ((uint32_t)state == 0) state = 1;
+
+      unsigned long pre = 1 + nextRandom(state) % 300;
+      unsigned long onTime = nextRandom(state) % (pre + 1);
+
+      Multi_Timer *ref = makeReferenceTimer(kind, pre, onTime);
+      CandidateEngine *cand = factory();
+      cand->begin(kind, pre, onTime);
+
+      TimerInputs in = { false, false, false, false };
+      unsigned long now = nextRandom(state) % 1000;
+
+      // Every other latched trial runs on Start() pulses and reset
+      bool episodes = (kind == LATCHED and (trial & 1));
+      LatchScript latch;
+      nextLatchEpisode(state, latch, now, pre);
+
+      for (unsigned long scan = 0; scan < scans; scan++) {
+        if (!episodes) nextInputs(state, in);
+        now += nextGap(state, pre);
+        if (episodes) nextLatchInputs(state, latch, now, pre, in);
+        hostSetMillis(now);
+
+        applyInputs(ref, kind, in);
+        ref->update();
+        cand->apply(in);
+        cand->scan(now);
+
+        TimerSnapshot want = readSnapshot(ref, kind);
+        TimerSnapshot got = cand->read();
+        if (!(want == got)) {
+          printf("%s diverges: seed %lu trial %lu scan %lu at %lu ms\n",
+                 timerKindName(kind), seed, trial, scan, now);
+          printf("    preset %lu onTime %lu, inputs enable %d reset %d ctrl %d start %d\n",
+                 pre, onTime, in.enable, in.reset, in.ctrl, in.start);
+          printSnapshot("reference", want);
+          printSnapshot("candidate", got);
+          kindSame = false;
+          break;
+        }
+      }
+      delete cand;
+      dropReferenceTimer(ref, kind);
+    }
+    same = same and kindSame;
+  }
+  return same;
+}
+
+/*======================================
+
+    Throughput
+--------------------------------------*/
+
+typedef std::chrono::steady_clock Clock;
+
+// Long presets and slowly changing inputs, as in a real sketch
+static void throughputInputs(unsigned long s, unsigned long flip,
+                             TimerInputs &in) {
+  in.enable = (s / flip) & 1;
+  in.start = (s % flip == 0);  // latched timers
+  in.reset = (s % flip >= flip - 10);
+}
+
+// Seconds taken for scans [from, from + scans) of every timer
+static double timeReference(std::vector<Multi_Timer *> &ref, TimerKind kind,
+                            const std::vector<unsigned long> &flip,
+                            unsigned long from, unsigned long scans) {
+  volatile unsigned long sink = 0;  // keep the work from being optimized out
+  TimerInputs in = { false, false, false, false };
+  Clock::time_point t0 = Clock::now();
+  for (unsigned long s = from; s < from + scans; s++) {
+    hostSetMillis(s);
+    for (size_t i = 0; i < ref.size(); i++) {
+      throughputInputs(s, flip[i], in);
+      applyInputs(ref[i], kind, in);
+      ref[i]->update();
+      sink = sink + readSnapshot(ref[i], kind).count;
+    }
+  }
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static double timeCandidate(std::vector<CandidateEngine *> &cand,
+                            const std::vector<unsigned long> &flip,
+                            unsigned long from, unsigned long scans) {
+  volatile unsigned long sink = 0;
+  TimerInputs in = { false, false, false, false };
+  Clock::time_point t0 = Clock::now();
+  for (unsigned long s = from; s < from + scans; s++) {
+    hostSetMillis(s);
+    for (size_t i = 0; i < cand.size(); i++) {
+      throughputInputs(s, flip[i], in);
+      cand[i]->apply(in);
+      cand[i]->scan(s);
+      sink = sink + cand[i]->read().count;
+    }
+  }
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static double median(std::vector<double> &v) {
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+void compareThroughput(CandidateFactory factory, TimerKind kind,
+                       unsigned long count, unsigned long scans,
+                       double &refRate, double &candRate,
+                       uint64_t &refUpdates, uint64_t &candUpdates) {
+  const int rounds = 7;  // odd, for the median
+
+  unsigned long state = 12345;
+  std::vector<unsigned long> pre(count), flip(count);
+  for (unsigned long i = 0; i < count; i++) {
+    pre[i] = 1000 + nextRandom(state) % 4000;
+    flip[i] = 2000 + nextRandom(state) % 8000;
+  }
+
+  std::vector<Multi_Timer *> ref(count);
+  std::vector<CandidateEngine *> cand(count);
+  for (unsigned long i = 0; i < count; i++) {
+    ref[i] = makeReferenceTimer(kind, pre[i], pre[i] / 2);
+    cand[i] = factory();
+    cand[i]->begin(kind, pre[i], pre[i] / 2);
+  }
+
+  // Both sides cover the same stretch of clock each round.  They
+  // take turns going first, after a warm-up round, and the median
+  // round of each is kept so one slow round on a busy host does
+  // not decide it.
+  timeReference(ref, kind, flip, 0, scans);
+  timeCandidate(cand, flip, 0, scans);
+
+  candUpdates = 0;
+  for (unsigned long i = 0; i < count; i++) {
+    candUpdates -= cand[i]->getUpdates();  // leave out the warm-up
+  }
+
+  double timerScans = (double)scans * count;
+  std::vector<double> refRates, candRates;
+  for (int r = 1; r <= rounds; r++) {
+    unsigned long from = r * scans;
+    double refTime, candTime;
+    if (r & 1) {
+      refTime = timeReference(ref, kind, flip, from, scans);
+      candTime = timeCandidate(cand, flip, from, scans);
+    } else {
+      candTime = timeCandidate(cand, flip, from, scans);
+      refTime = timeReference(ref, kind, flip, from, scans);
+    }
+    refRates.push_back(timerScans / refTime);
+    candRates.push_back(timerScans / candTime);
+  }
+  refRate = median(refRates);
+  candRate = median(candRates);
+
+  refUpdates = (uint64_t)rounds * scans * count;
+  for (unsigned long i = 0; i < count; i++) {
+    candUpdates += cand[i]->getUpdates();
+  }
+
+  for (unsigned long i = 0; i < count; i++) {
+    delete cand[i];
+    dropReferenceTimer(ref[i], kind);
+  }
+}
+
+/*======================================
+
+    Event skipping candidate
+--------------------------------------*/
+
+EventSkipEngine::EventSkipEngine() {
+  _Timer = nullptr;
+}
+
+EventSkipEngine::~EventSkipEngine() {
+  if (_Timer != nullptr) dropReferenceTimer(_Timer, _Kind);
+}
+
+CandidateEngine *EventSkipEngine::make() {
+  return new EventSkipEngine();
+}
+
+void EventSkipEngine::begin(TimerKind kind, unsigned long pre,
+                            unsigned long onTime) {
+  _Timer = makeReferenceTimer(kind, pre, onTime);
+  _Kind = kind;
+  _Inputs = TimerInputs{ false, false, false, false };
+  _Changed = true;  // first scan always updates
+  _Recheck = false;
+  _Now = 0;
+  _LastScan = 0;
+  _LastUpdate = 0;
+  _Wait = 0;
+  _Updates = 0;
+}
+
+void EventSkipEngine::apply(const TimerInputs &in) {
+  if (in.enable != _Inputs.enable or in.reset != _Inputs.reset
+      or in.ctrl != _Inputs.ctrl or in.start != _Inputs.start) {
+    _Changed = true;
+  }
+  _Inputs = in;
+}
+
+void EventSkipEngine::scan(unsigned long now) {
+  _LastScan = _Now;
+  _Now = now;
+
+  if (_Changed and _LastUpdate != _LastScan) {
+    // The reference updated at the last scan with the old inputs.
+    // Nothing changed, but it moved _LastMillis up - do the same.
+    hostSetMillis(_LastScan);
+    _Timer->update();
+    _Updates++;
+    hostSetMillis(now);
+  }
+  // Outside of update() the timer's inputs only change here
+  if (_Changed or _Recheck) applyInputs(_Timer, _Kind, _Inputs);
+
+  if (_Recheck) {
+    _Wait = _Timer->timeToNextEvent();
+    _Recheck = false;
+  }
+  if (_Changed or now - _LastUpdate >= _Wait) {
+    _Timer->update();
+    _Updates++;
+    _LastUpdate = now;
+    _Changed = false;
+    _Recheck = true;
+  }
+}
+
+TimerSnapshot EventSkipEngine::read() {
+  TimerSnapshot snap = readSnapshot(_Timer, _Kind);
+  // A finite wait means the accumulator has been counting all along
+  if (_Wait != Multi_Timer::NO_EVENT) snap.count += _Now - _LastUpdate;
+  return snap;
+}
+
+uint64_t EventSkipEngine::getUpdates() const {
+  return _Updates;
+}
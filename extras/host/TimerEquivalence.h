@@ -0,0 +1,164 @@
+/* filename: TimerEquivalence.h  (host only)
+
+Differential equivalence harness for Multi_Timer_V2.
+
+Any faster way of updating timers has to behave exactly like the
+reference classes - every flag on every scan, one-scan _Done_OSR /
+_Done_OSF pulses included, and every accumulated count.  The harness
+drives a reference timer and a candidate engine with identical
+scripted input streams and clock, compares them after every scan
+and reports the first divergence.  It also runs both side by side,
+timing them and counting their update() calls, so a candidate is
+only accepted when it is proven equivalent and does less work.
+
+A candidate engine models one timer.  Implement CandidateEngine and
+pass a factory for it to checkEquivalence() / compareThroughput().
+EventSkipEngine, the one supplied, updates only when
+timeToNextEvent() says something can change.
+*/
+
+#ifndef MULTI_TIMER_EQUIVALENCE_H
+#define MULTI_TIMER_EQUIVALENCE_H
+
+#include "Multi_Timer_V2.h"
+
+#ifndef MULTI_TIMER_EVENTS
+#error "needs MULTI_TIMER_EVENTS - build with the Arduino.h in extras/host"
+#endif
+
+enum TimerKind {
+  ON_DELAY,
+  OFF_DELAY,
+  RETENTIVE,
+  PULSE_GEN,
+  LATCHED,
+  RETRIGGERABLE,
+  FLASHER,
+  TOTALIZER,   // TotalizerTimer in TOTALIZER_UNIT ms units
+  TIMER_KINDS  // number of kinds
+};
+
+// Short, so random presets and scan gaps cross many units
+const unsigned long TOTALIZER_UNIT = 7;
+
+const char *timerKindName(TimerKind);
+
+// Inputs applied before each scan
+struct TimerInputs {
+  bool enable;  // not LatchedTimer
+  bool reset;
+  bool ctrl;    // setCtrl(), not LatchedTimer
+  bool start;   // LatchedTimer::Start()
+};
+
+// Everything a sketch can read back after a scan
+struct TimerSnapshot {
+  bool done;
+  bool running;
+  bool doneRose;
+  bool doneFell;
+  bool flashing;  // FlasherTimer only
+  unsigned long count;  // TotalizerTimer: in ms, sub-counter included
+};
+
+bool operator==(const TimerSnapshot &, const TimerSnapshot &);
+
+class CandidateEngine {
+public:
+  virtual ~CandidateEngine() {}
+
+  // Set up as a timer of this kind
+  virtual void begin(TimerKind, unsigned long pre, unsigned long onTime) = 0;
+
+  // Inputs for the coming scan
+  virtual void apply(const TimerInputs &) = 0;
+
+  // One scan at millis() == now.  May move millis() about, but
+  // leaves it at now.
+  virtual void scan(unsigned long now) = 0;
+
+  // State as of the latest scan
+  virtual TimerSnapshot read() = 0;
+
+  // Timer update()s, or the engine's equivalent unit of work, done
+  // so far.  The reference does one per scan.
+  virtual uint64_t getUpdates() const = 0;
+};
+
+typedef CandidateEngine *(*CandidateFactory)();
+
+// Reference timer of the given kind.  Storage is zeroed first, as
+// for a global object in a sketch.  Multi_Timer has no virtual
+// destructor, so give it back with dropReferenceTimer().
+Multi_Timer *makeReferenceTimer(TimerKind, unsigned long pre, unsigned long onTime);
+void dropReferenceTimer(Multi_Timer *, TimerKind);
+
+void applyInputs(Multi_Timer *, TimerKind, const TimerInputs &);
+TimerSnapshot readSnapshot(Multi_Timer *, TimerKind);
+
+// Reproducible random numbers for scripted inputs.  'state' is the
+// seed to start with and must not be zero.
+unsigned long nextRandom(unsigned long &state);
+
+/*----------------------------------------------------------------
+  Randomized check - 'trials' timers of each kind, 'scans' scans
+  each, random presets, inputs and scan gaps from 'seed'.  Prints
+  the first divergence of each kind.  Returns true if none.
+  Every other LatchedTimer trial runs on single Start() pulses,
+  with reset raised and held before the timer can be done.
+  ----------------------------------------------------------------*/
+bool checkEquivalence(CandidateFactory, unsigned long seed,
+                      unsigned long trials, unsigned long scans);
+
+/*----------------------------------------------------------------
+  Throughput - 'count' timers of one kind, 1 ms scans with inputs
+  changing now and then.  Both are run in alternating rounds of
+  'scans' scans after a warm-up.  Fills in the median scans per
+  second of each, and the updates each made over all rounds - a
+  measure of work that, unlike the rates, doesn't vary run to run.
+  ----------------------------------------------------------------*/
+void compareThroughput(CandidateFactory, TimerKind, unsigned long count,
+                       unsigned long scans, double &refRate, double &candRate,
+                       uint64_t &refUpdates, uint64_t &candUpdates);
+
+/*================================================================
+
+          Event skipping candidate
+------------------------------------------------------------------
+Wraps a reference timer and calls its update() only on scans where
+timeToNextEvent() or an input change says something can change.
+In between, getCount() is carried forward from the clock.  The
+wrapped timer is asked again on the scan after each update, once
+the new inputs are in, since update() may have used some up (a
+latched _Control cleared by reset, say).  When inputs change after
+skipped scans the timer is first brought up to the last scan, as
+the reference timer was.
+------------------------------------------------------------------*/
+
+class EventSkipEngine : public CandidateEngine {
+public:
+  EventSkipEngine();
+  ~EventSkipEngine();
+
+  virtual void begin(TimerKind, unsigned long, unsigned long);
+  virtual void apply(const TimerInputs &);
+  virtual void scan(unsigned long);
+  virtual TimerSnapshot read();
+  virtual uint64_t getUpdates() const;
+
+  static CandidateEngine *make();
+
+private:
+  Multi_Timer *_Timer;
+  TimerKind _Kind;
+  TimerInputs _Inputs;
+  bool _Changed;  // inputs differ from the last scan
+  bool _Recheck;  // updated last scan - ask again with new inputs
+  unsigned long _Now;
+  unsigned long _LastScan;
+  unsigned long _LastUpdate;
+  unsigned long _Wait;
+  uint64_t _Updates;
+};
+
+#endif
@@ -0,0 +1,87 @@
+// filename: TimerSimulator.cpp  (host only)
+//
+// Event-driven, time-compressed driver for Multi_Timer_V2 objects.
+// See TimerSimulator.h.
+//
+// All the arithmetic is done as offsets from the current scan, so
+// it holds across millis() rolling over.
+
+#include "TimerSimulator.h"
+
+TimerSimulator::TimerSimulator(uint32_t scan) {
+  _Scan = (scan == 0) ? 1 : scan;
+  _Now = 0;
+  _Wake = 0;
+  _WakeSet = false;
+  _Scans = 0;
+  _PolledScans = 0;
+}
+
+// Offset from now of the first scan at least 'wait' ms away,
+// never less than one scan.
+uint64_t TimerSimulator::offsetAfter(uint64_t wait) const {
+  if (wait <= _Scan) return _Scan;
+  return ((wait - 1) / _Scan + 1) * _Scan;
+}
+
+uint64_t TimerSimulator::run(uint32_t duration, void (*loopFn)()) {
+  uint64_t scansBefore = _Scans;
+  uint64_t left = duration;  // ms from this scan to the end
+
+  while (true) {
+    hostSetMillis(_Now);
+    Multi_Timer::updateAllTimers();
+    ++_Scans;
+    if (loopFn != nullptr) loopFn();
+
+    // Inputs are final for this scan - find the next one that matters
+    unsigned long wait = Multi_Timer::timeToNextEventAll();
+    uint64_t ahead = UINT64_MAX;
+    if (wait != Multi_Timer::NO_EVENT) ahead = offsetAfter(wait);
+    if (_WakeSet) {
+      uint32_t until = _Wake - _Now;  // past requests wrap to > 2^31
+      uint64_t wake = (until > 0x80000000UL) ? _Scan : offsetAfter(until);
+      if (wake <= ahead) {
+        ahead = wake;
+        _WakeSet = false;
+      }
+    }
+
+    if (ahead > left) {
+      // Nothing happens before the end - carry on from the first
+      // scan after it next time.
+      uint64_t resume = offsetAfter(left + 1);
+      _PolledScans += resume / _Scan;
+      _Now += (uint32_t)resume;
+      break;
+    }
+    _PolledScans += ahead / _Scan;
+    _Now += (uint32_t)ahead;
+    left -= ahead;
+  }
+  return _Scans - scansBefore;
+}
+
+void TimerSimulator::wakeAt(uint32_t when) {
+  // Compare as offsets from now, anything in the past as zero
+  uint32_t until = when - _Now;
+  uint32_t pending = _Wake - _Now;
+  if (until > 0x80000000UL) until = 0;
+  if (pending > 0x80000000UL) pending = 0;
+  if (!_WakeSet or until < pending) {
+    _Wake = when;
+    _WakeSet = true;
+  }
+}
+
+uint32_t TimerSimulator::now() const {
+  return _Now;
+}
+
+uint64_t TimerSimulator::getScans() const {
+  return _Scans;
+}
+
+uint64_t TimerSimulator::getPolledScans() const {
+  return _PolledScans;
+}
@@ -0,0 +1,71 @@
+/* filename: TimerSimulator.h  (host only)
+
+Event-driven, time-compressed driver for Multi_Timer_V2 objects.
+
+A real sketch calls updateAllTimers() and then its own loop code
+every scan, 'scan' milliseconds apart.  TimerSimulator produces the
+same flags and counts at the same instants but only performs the
+scans where something can change - it asks every timer for
+timeToNextEvent(), jumps the virtual clock to the first scan at or
+after the soonest one and runs updateAllTimers() and the loop
+function there.  Hours of timer logic execute in milliseconds.
+
+The loop function is run after every update, just as loop() would
+be, so it may read flags and set inputs as usual.  Things it can't
+see from the timers - an input scripted to change at a certain
+time - must be requested with wakeAt() or the simulator may jump
+straight past them.  Code which counts scans rather than reacting
+to flags will of course see fewer of them.
+
+Build with the shim Arduino.h in this folder, e.g.
+  g++ -I extras/host -I src src/Multi_Timer_v2.cpp
+      extras/host/Arduino.cpp extras/host/TimerSimulator.cpp mysim.cpp
+*/
+
+#ifndef MULTI_TIMER_SIMULATOR_H
+#define MULTI_TIMER_SIMULATOR_H
+
+#include "Multi_Timer_V2.h"
+
+#ifndef MULTI_TIMER_EVENTS
+#error "needs MULTI_TIMER_EVENTS - build with the Arduino.h in extras/host"
+#endif
+
+// Times are 32-bit milliseconds, like millis() on a board, and
+// roll over the same way.  Scans land every scan interval from the
+// first one, across rollovers too, as a polled loop()'s would.
+
+class TimerSimulator {
+public:
+  TimerSimulator(uint32_t);  // scan interval, milliseconds
+
+  // Run loopFn after each update for 'duration' ms of virtual
+  // time.  Returns the number of scans actually performed.
+  uint64_t run(uint32_t duration, void (*loopFn)());
+
+  // Make sure a scan happens at (or just after) 'when', which may
+  // be up to 2^31 ms ahead.  Only the earliest request is kept -
+  // ask for the next one from loopFn.
+  void wakeAt(uint32_t when);
+
+  // Virtual time of the current scan.  Once run() returns, the
+  // time of the next scan.
+  uint32_t now() const;
+
+  // Scans performed so far, and the scans a polled run would have
+  // made over the same time
+  uint64_t getScans() const;
+  uint64_t getPolledScans() const;
+
+private:
+  uint64_t offsetAfter(uint64_t) const;
+
+  uint32_t _Scan;
+  uint32_t _Now;
+  uint32_t _Wake;
+  bool _WakeSet;
+  uint64_t _Scans;
+  uint64_t _PolledScans;
+};
+
+#endif
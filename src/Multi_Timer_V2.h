@@ -93,7 +93,43 @@ public:
 
   static void updateAllTimers();
 
+  /* =============================================================
+              Time To Next Event
+   ---------------------------------------------------------------
+   Returns the number of milliseconds, given the present inputs,
+   before an update() could change this timer's flags or stop its
+   accumulator.  Returns zero if the next update() will change
+   something (a one-shot to clear, a reset to apply) and NO_EVENT
+   if nothing will change until an input does.  Any other value
+   means the accumulator is counting up meanwhile.
+
+   Lets a caller - e.g. a host simulation - skip the updates in
+   between.  Types which don't override this return zero, which
+   just means 'update every scan'.
+
+   Only built when MULTI_TIMER_EVENTS is defined, and only the
+   host Arduino.h in extras/host defines it.  Never define it in
+   a sketch: it adds a virtual function to every timer class, and
+   the IDE compiles the library without it, so sketch and library
+   would disagree on the vtables and timeToNextEventAll() would
+   not link.
+   ----------------------------------------------------------------*/
+
+#ifdef MULTI_TIMER_EVENTS
+  static const unsigned long NO_EVENT = (unsigned long)-1;
+
+  virtual unsigned long timeToNextEvent() const;
+
+  // Smallest timeToNextEvent() of all timer objects
+  static unsigned long timeToNextEventAll();
+#endif
+
 protected:
+#ifdef MULTI_TIMER_EVENTS
+  // Common timeToNextEvent() logic for the base class update().
+  // 'rst' is the derived class' reset() condition.
+  unsigned long eventAfter(bool rst) const;
+#endif
 
   bool _Reset : 1;
   bool _Enable : 1;
@@ -133,6 +169,9 @@ public:
   ~OnDelayTimer();              // destructor
 
   virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
 };  // End of class OnDelayTimer
 
 /*===================================================================
@@ -155,6 +194,9 @@ public:
   virtual bool update();
 
   virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
 };  // End of class OffDelayTimer
 
 /*==============================================================
@@ -175,6 +217,9 @@ public:
 
   // Establish reset conditions for retentive ON delay timer
   virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
 };  // End of class retentive timer
 
 /*==============================================================
@@ -195,6 +240,9 @@ public:
 
   // Establish reset conditions for pulse generator timer
   virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
 };  //End of class PulseGenTimer
 //-------------------------------------------
 
@@ -220,6 +268,9 @@ public:
 
   // Establish reset conditions for self-latching ON delay timer
   virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
 };
 // End of class LatchedTimer
 //-----------------------------------------------------
@@ -243,6 +294,9 @@ public:
   ~RetriggerableTimer();
 
   virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
 
 private:
   bool _WD_Rising_OS : 1;
@@ -275,6 +329,11 @@ public:
 
   virtual bool reset();
 
+#ifdef MULTI_TIMER_EVENTS
+  // Also reports the isFlashing() ON time running out
+  virtual unsigned long timeToNextEvent() const;
+#endif
+
   // 4/2/24 : Moved _FlashOut decision from update() to getFlash()
   // so that _FlashOut code only applies to FlasherTimer objects.
   //
@@ -289,4 +348,138 @@ public:
 // end of class FlasherTimer
 //---------------------------------------------
 
+/*==============================================================
+
+             Totalizer timer class definition
+--------------------------------------------------------------
+A retentive timer for run-hour meters and the like, which can
+run well past the 49.7 days a millisecond accumulator allows.
+Milliseconds are gathered in a sub-counter and rolled over into
+a count of larger units - seconds, minutes or hours - so both
+the preset and getCount() are in those units.
+
+Accumulates when enabled, holds when enable is false and is
+reset only by making the reset input true.  Uses no more RAM
+than a RetentiveTimer and no 64-bit arithmetic: the unit length
+is kept in _OnTime and the sub-counter in _CurrentMillis.
+--------------------------------------------------------------*/
+
+class TotalizerTimer : public Multi_Timer {
+public:
+  // Unit lengths for the second constructor argument
+  static const unsigned long SECONDS = 1000UL;
+  static const unsigned long MINUTES = 60000UL;
+  static const unsigned long HOURS = 3600000UL;
+
+  TotalizerTimer(unsigned long, unsigned long);  // preset, unit length
+  ~TotalizerTimer();
+
+  virtual bool update();
+
+  virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
+
+  // Milliseconds gathered toward the next whole unit
+  unsigned long getSubCount() const;
+};
+// End of class TotalizerTimer
+
+/*=================================================================
+
+                 Phase Engine class definition
+-----------------------------------------------------------------
+Drives up to 32 on/off output channels from one shared period,
+replacing a bank of FlasherTimers.  Each channel has its own
+duty (ON milliseconds per period) and phase (offset of its ON
+point into the period).
+
+The ON and OFF points of all channels are kept in one sorted
+compare list, so update() only visits the points passed since
+the last scan - the cost is per transition, not per channel.
+Channel states are kept as a bitmask, channel 0 in bit 0, ready
+to be written to a port in one go.
+
+Runs when enabled and not reset.  When stopped all outputs are
+off and the next start begins again at the top of the period.
+getDoneRose() is true for one scan as each period begins.
+isDone(), getDoneFell() and setCtrl() are inherited but mean
+nothing here - there is no done state and no control input.
+setChannel() may be called while running; other channels are
+left alone, unlike FlasherTimer::setOnTime().
+
+Declare as PhaseEngine<number of channels>.
+--------------------------------------------------------------------*/
+
+struct PhaseChannel {
+  unsigned long onAt;   // ON point in the period
+  unsigned long offAt;  // OFF point in the period
+};
+
+class PhaseEngineBase : public Multi_Timer {
+public:
+  ~PhaseEngineBase();
+
+  virtual bool update();
+
+  virtual bool reset();
+#ifdef MULTI_TIMER_EVENTS
+  virtual unsigned long timeToNextEvent() const;
+#endif
+
+  // Set a channel's ON time and phase offset, in milliseconds.
+  // duty 0 is always off, duty >= period always on.
+  void setChannel(uint8_t, unsigned long, unsigned long);
+
+  // Change a channel's ON time, keeping its phase
+  void setDuty(uint8_t, unsigned long);
+
+  // State of one channel
+  bool isOn(uint8_t) const;
+
+  // States of all channels, channel 0 in bit 0
+  unsigned long getStates() const;
+
+protected:
+  PhaseEngineBase(unsigned long, uint8_t, PhaseChannel *, uint8_t *);
+
+  // Sets every channel to always off
+  void clearChannels();
+
+private:
+  unsigned long edgeAt(uint8_t) const;
+  bool edgeLater(uint8_t, uint8_t) const;
+  bool channelOn(uint8_t) const;
+  void sortEdges();
+  void refresh();
+  void seek();
+  void walk(unsigned long);
+
+  PhaseChannel *_Chan;
+  uint8_t *_Edges;  // sorted compare list - channel * 2, +1 for OFF
+  uint8_t _Channels;
+  uint8_t _Cursor;     // next entry in _Edges to be reached
+  uint8_t _Switching;  // entries of channels that switch, at the head
+  unsigned long _States;
+  unsigned long _FixedMask;  // channels always on or always off
+};
+
+template <uint8_t N>
+class PhaseEngine : public PhaseEngineBase {
+  static_assert(N >= 1 and N <= 32, "PhaseEngine drives 1 to 32 channels");
+
+public:
+  PhaseEngine(unsigned long period)
+    : PhaseEngineBase(period, N, _ChanStore, _EdgeStore) {
+    clearChannels();
+  }
+
+private:
+  PhaseChannel _ChanStore[N];
+  uint8_t _EdgeStore[2 * N];
+};
+// end of class PhaseEngine
+//---------------------------------------------
+
 #endif
@@ -146,7 +146,9 @@ bool Multi_Timer::getDoneFell() const {
 bool Multi_Timer::update() {
   _CurrentMillis = millis();  // Get system clock ticks
   if (_Enable or _Control) {  // timer is enabled to run
-    _Accumulator = _Accumulator + _CurrentMillis - _LastMillis;
+    // millis() is 32 bits and rolls over - so must the difference,
+    // even where unsigned long is wider (a host build)
+    _Accumulator = _Accumulator + (uint32_t)(_CurrentMillis - _LastMillis);
     if (_Accumulator >= _Preset) {  // timer done?
       _Accumulator = _Preset;       // Don't let accumulator run away
       _Done = true;
@@ -198,6 +200,52 @@ void Multi_Timer::updateAllTimers() {
   }
 }  // end of updateAllTimers
 
+#ifdef MULTI_TIMER_EVENTS
+/* ===================================================
+
+              Time To Next Event
+   ---------------------------------------------------
+   Nothing in update() changes between events as long
+   as the inputs don't, so a caller may skip the scans
+   in between and still see the same flags.
+   ---------------------------------------------------
+*/
+const unsigned long Multi_Timer::NO_EVENT;
+
+// Default for types which don't know better - update every scan
+unsigned long Multi_Timer::timeToNextEvent() const {
+  return 0;
+}
+
+unsigned long Multi_Timer::timeToNextEventAll() {
+  unsigned long soonest = NO_EVENT;
+  for (Multi_Timer *ptr = first; ptr != nullptr; ptr = ptr->next) {
+    unsigned long t = ptr->timeToNextEvent();
+    if (t < soonest) soonest = t;
+    if (soonest == 0) break;  // can't get any sooner
+  }
+  return soonest;
+}
+
+// Mirrors update() without changing anything.  'rst' is what
+// the derived class' reset() would return.
+unsigned long Multi_Timer::eventAfter(bool rst) const {
+  if (_Done_OSR or _Done_OSF) return 0;  // one-shots clear next scan
+
+  bool run = (_Enable or _Control);
+  if (rst) {
+    if (_Done or _Accumulator != 0 or _Control) return 0;  // reset pending
+    // Held at reset - anything accumulated is cleared every scan
+    return (_TimerRunning == (_Enable and !_Reset)) ? NO_EVENT : 0;
+  }
+  if (_TimerRunning != (run and !_Done and !_Reset)) return 0;
+  if (!run or _Done) return NO_EVENT;  // stopped or already done
+
+  if (_Accumulator >= _Preset) return 0;
+  return _Preset - _Accumulator;  // time left to preset
+}
+#endif
+
 /* ================================================
 
             On Delay Timer class definition
@@ -229,6 +277,12 @@ bool OnDelayTimer::reset() {
   return (_Reset or !_Enable);
 }  // End of OnDelay timer
 
+#ifdef MULTI_TIMER_EVENTS
+unsigned long OnDelayTimer::timeToNextEvent() const {
+  return eventAfter(_Reset or !_Enable);
+}
+#endif
+
 /*=======================================================
 
                Off Delay Timer class definition
@@ -264,7 +318,7 @@ bool OffDelayTimer::update() {
                               // Serial.println(enableOff);
   if (enableOff) {            // timer is enabled to run
 
-    _Accumulator = _Accumulator + _CurrentMillis - _LastMillis;
+    _Accumulator = _Accumulator + (uint32_t)(_CurrentMillis - _LastMillis);
     if (_Accumulator >= _Preset) {  // timer done?
       _Accumulator = _Preset;       // Don't let accumulator run away
       _Done = false;
@@ -304,6 +358,24 @@ bool OffDelayTimer::reset() {
   return (_Reset or _Enable);
 }  // End of OffDelay timer
 
+#ifdef MULTI_TIMER_EVENTS
+// Mirrors the redefined update() above
+unsigned long OffDelayTimer::timeToNextEvent() const {
+  if (_Done_OSR or _Done_OSF) return 0;  // one-shots clear next scan
+
+  if (_Reset or _Enable) {  // held reset, done stays true
+    if (!_Done or _Accumulator != 0 or _TimerRunning) return 0;
+    return NO_EVENT;
+  }
+  if (_TimerRunning != (bool)_Done) return 0;
+
+  // Still counting up to preset - also true from power-up, before
+  // done has ever been set
+  if (_Accumulator < _Preset) return _Preset - _Accumulator;
+  return _Done ? 0 : NO_EVENT;  // timed out, waiting for enable
+}
+#endif
+
 /*==============================================================
 
              Retentive timer class definition
@@ -324,6 +396,12 @@ bool RetentiveTimer::reset() {
   return (_Reset);
 }  // End of Retentive timer
 
+#ifdef MULTI_TIMER_EVENTS
+unsigned long RetentiveTimer::timeToNextEvent() const {
+  return eventAfter(_Reset);
+}
+#endif
+
 /*==============================================================
 
               Pulse Generator Timer Definition
@@ -346,6 +424,12 @@ bool PulseGenTimer::reset() {
   return(_Reset or _Done_OSR);
 }  //End of class PulseGenTimer
 
+#ifdef MULTI_TIMER_EVENTS
+unsigned long PulseGenTimer::timeToNextEvent() const {
+  return eventAfter(_Reset or _Done_OSR);
+}
+#endif
+
 /*============================================================
 
          Latched /Retentive/ timer class definition
@@ -377,6 +461,12 @@ bool LatchedTimer::reset() {
   return (_Reset and _Done);
 }  // End of class LatchedTimer
 
+#ifdef MULTI_TIMER_EVENTS
+unsigned long LatchedTimer::timeToNextEvent() const {
+  return eventAfter(_Reset and _Done);
+}
+#endif
+
 /*=================================================================
 
                    Retriggerable Monostable timer
@@ -407,6 +497,16 @@ bool RetriggerableTimer::reset() {
 
 }  // End of Retriggerable timer
 
+#ifdef MULTI_TIMER_EVENTS
+unsigned long RetriggerableTimer::timeToNextEvent() const {
+  // A control edge not yet seen by reset() restarts the timer
+  if ((_Control and _WD_Rising_Setup) or (!_Control and _WD_Falling_Setup)) {
+    return 0;
+  }
+  return eventAfter(_Reset);
+}
+#endif
+
 /*=================================================================
 
                  FlasherTimer Timer class definition
@@ -452,3 +552,337 @@ void FlasherTimer::setOnTime(unsigned long newOnTime) {
   _Accumulator = _Preset;  // Force a reset when new onTime loaded
 }
 // End of FlasherTimer timer
+
+#ifdef MULTI_TIMER_EVENTS
+// Adds the point where isFlashing() goes false to the base events
+unsigned long FlasherTimer::timeToNextEvent() const {
+  // Just enabled - isFlashing() follows _Enable straight away, even
+  // with reset held when _TimerRunning stays false
+  if (_Enable and _Accumulator == 0 and !_Done) return 0;
+
+  unsigned long t = eventAfter(!_Enable or _Done_OSR);
+  if (t != NO_EVENT and _Accumulator <= _OnTime) {  // counting
+    unsigned long flashOff = _OnTime - _Accumulator + 1;
+    if (flashOff < t) t = flashOff;
+  }
+  return t;
+}
+#endif
+
+/*==============================================================
+
+             Totalizer timer class definition
+--------------------------------------------------------------
+A retentive timer counting in units of _OnTime milliseconds.
+_CurrentMillis holds the milliseconds gathered toward the next
+whole unit and _Accumulator the whole units.  update() is
+redefined to roll one into the other.  The division only runs
+when a unit completes and stays within 32 bits.
+--------------------------------------------------------------*/
+
+const unsigned long TotalizerTimer::SECONDS;
+const unsigned long TotalizerTimer::MINUTES;
+const unsigned long TotalizerTimer::HOURS;
+
+TotalizerTimer::TotalizerTimer(unsigned long pre, unsigned long unit)
+  : Multi_Timer(pre, unit) {
+  if (_OnTime == 0) _OnTime = 1;  // guard the division
+  _CurrentMillis = 0;
+}
+
+TotalizerTimer::~TotalizerTimer() {}  // give a destructor
+
+// update function/method is redefined here
+
+bool TotalizerTimer::update() {
+  unsigned long now = millis();  // Get system clock ticks
+  if (_Enable or _Control) {     // timer is enabled to run
+    _CurrentMillis = _CurrentMillis + (uint32_t)(now - _LastMillis);
+    if (_CurrentMillis >= _OnTime) {  // roll whole units over
+      _Accumulator = _Accumulator + _CurrentMillis / _OnTime;
+      _CurrentMillis = _CurrentMillis % _OnTime;
+    }
+    if (_Accumulator >= _Preset) {  // timer done?
+      _Accumulator = _Preset;       // Don't let accumulator run away
+      _CurrentMillis = 0;
+      _Done = true;
+    }
+  }
+  _LastMillis = now;
+
+  if (reset()) {
+    _Done = false;
+    _Accumulator = 0;
+    _CurrentMillis = 0;
+    _Control = false;
+  }
+  /*-----
+    Generate a one-scan momentary flag on _Done
+    false-to-true transition
+  */
+  _Done_OSR = (_Done and _Done_Rising_Setup);  // timer done OS
+  _Done_Rising_Setup = !_Done;
+
+  /*----
+    and another one-scan momentary flag on _Done
+    true-to-false transition
+  */
+  _Done_OSF = (!_Done and _Done_Falling_Setup);  // timer not done OS
+  _Done_Falling_Setup = _Done;
+
+  /*
+     Condition the timer running flag.
+  */
+  if ((_Enable or _Control) and !_Done and !_Reset) {
+    _TimerRunning = true;
+  } else _TimerRunning = false;
+
+  return _Done;
+}
+
+// Establish reset conditions for totalizer timer
+bool TotalizerTimer::reset() {
+  return (_Reset);
+}
+
+#ifdef MULTI_TIMER_EVENTS
+unsigned long TotalizerTimer::timeToNextEvent() const {
+  if (_Reset and _CurrentMillis != 0) return 0;  // reset pending
+  unsigned long units = eventAfter(_Reset);
+  if (units == 0 or units == NO_EVENT) return units;
+
+  // Units left to preset, in milliseconds.  Too far off to say
+  // in 32 bits just means 'a long way off, still counting'.
+  if (units > (NO_EVENT - 1) / _OnTime) return NO_EVENT - 1;
+  return units * _OnTime - _CurrentMillis;
+}
+#endif
+
+unsigned long TotalizerTimer::getSubCount() const {
+  return _CurrentMillis;
+}
+// End of Totalizer timer
+
+/*=================================================================
+
+                 Phase Engine class definition
+-----------------------------------------------------------------
+Many on/off channels sharing one period.  _Accumulator is the
+position in the period, _Preset the period itself.
+
+_Edges is the compare list: every channel's ON point (channel * 2)
+and OFF point (channel * 2 + 1), sorted by position.  _Cursor is
+the first entry not yet reached this period, so a scan only has
+to look at the entries between the last position and the new one.
+
+Channels which are always on or always off have no transitions
+and are flagged in _FixedMask.  Their entries are sorted to the
+tail of the list, past _Switching, and never visited.  For those,
+offAt == onAt means off and anything else means on.
+*/
+
+PhaseEngineBase::PhaseEngineBase(unsigned long period, uint8_t channels,
+                                 PhaseChannel *chan, uint8_t *edges)
+  : Multi_Timer(period) {
+  if (_Preset == 0) _Preset = 1;  // guard the modulo below
+  _Chan = chan;
+  _Edges = edges;
+  _Channels = channels;
+  _Cursor = 0;
+  _Switching = 0;
+  _States = 0;
+  _FixedMask = 0;
+  _Accumulator = 0;
+  _TimerRunning = false;
+}
+
+PhaseEngineBase::~PhaseEngineBase() {}  // give a destructor
+
+// Called by PhaseEngine<N> once its storage exists
+void PhaseEngineBase::clearChannels() {
+  for (uint8_t ch = 0; ch < _Channels; ch++) {
+    _Chan[ch].onAt = 0;
+    _Chan[ch].offAt = 0;
+    _Edges[ch * 2] = ch * 2;
+    _Edges[ch * 2 + 1] = ch * 2 + 1;
+  }
+  _FixedMask = (_Channels >= 32) ? 0xFFFFFFFFUL : (1UL << _Channels) - 1;
+  _Switching = 0;
+  _States = 0;
+  _Cursor = 0;
+}
+
+// Position of one compare list entry
+unsigned long PhaseEngineBase::edgeAt(uint8_t edge) const {
+  const PhaseChannel &c = _Chan[edge >> 1];
+  return (edge & 1) ? c.offAt : c.onAt;
+}
+
+// What a channel should show at the current position
+bool PhaseEngineBase::channelOn(uint8_t ch) const {
+  const PhaseChannel &c = _Chan[ch];
+  if (_FixedMask & (1UL << ch)) return (c.offAt != c.onAt);
+  if (c.onAt < c.offAt) {
+    return (_Accumulator >= c.onAt and _Accumulator < c.offAt);
+  }
+  // ON time wraps past the end of the period
+  return (_Accumulator >= c.onAt or _Accumulator < c.offAt);
+}
+
+// True if entry 'a' belongs after entry 'b' - switching channels
+// by position, then the fixed ones
+bool PhaseEngineBase::edgeLater(uint8_t a, uint8_t b) const {
+  bool aFixed = _FixedMask & (1UL << (a >> 1));
+  bool bFixed = _FixedMask & (1UL << (b >> 1));
+  if (aFixed or bFixed) return (aFixed and !bFixed);
+  return edgeAt(a) > edgeAt(b);
+}
+
+// Insertion sort - only one channel moves at a time, so the
+// list is nearly in order already.
+void PhaseEngineBase::sortEdges() {
+  uint8_t count = _Channels * 2;
+  _Switching = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t edge = _Edges[i];
+    uint8_t j = i;
+    while (j > 0 and edgeLater(_Edges[j - 1], edge)) {
+      _Edges[j] = _Edges[j - 1];
+      j--;
+    }
+    _Edges[j] = edge;
+    if (!(_FixedMask & (1UL << (edge >> 1)))) _Switching++;
+  }
+}
+
+// Rebuild all states and the cursor from the current position
+void PhaseEngineBase::refresh() {
+  _States = 0;
+  for (uint8_t ch = 0; ch < _Channels; ch++) {
+    if (channelOn(ch)) _States |= (1UL << ch);
+  }
+  seek();
+}
+
+// Point the cursor past every entry already reached this period
+void PhaseEngineBase::seek() {
+  _Cursor = 0;
+  while (_Cursor < _Switching and edgeAt(_Edges[_Cursor]) <= _Accumulator) {
+    _Cursor++;
+  }
+}
+
+// Apply every compare list entry up to and including 'limit'
+void PhaseEngineBase::walk(unsigned long limit) {
+  while (_Cursor < _Switching) {
+    uint8_t edge = _Edges[_Cursor];
+    if (edgeAt(edge) > limit) break;
+    unsigned long bit = 1UL << (edge >> 1);
+    if (edge & 1) {
+      _States &= ~bit;
+    } else _States |= bit;
+    _Cursor++;
+  }
+}
+
+// update function/method is redefined here.  Returns true on
+// the scan a new period begins.
+bool PhaseEngineBase::update() {
+  _CurrentMillis = millis();  // Get system clock ticks
+  unsigned long elapsed = (uint32_t)(_CurrentMillis - _LastMillis);
+  _LastMillis = _CurrentMillis;
+  _Done_OSR = false;
+
+  if (reset()) {  // stopped - all outputs off
+    _TimerRunning = false;
+    _Accumulator = 0;
+    _States = 0;
+    return false;
+  }
+
+  if (!_TimerRunning) {  // start at the top of the period
+    _TimerRunning = true;
+    _Accumulator = 0;
+    _Done_OSR = true;
+    refresh();
+  } else if (elapsed >= _Preset) {  // missed a whole period or more
+    _Accumulator = (_Accumulator + elapsed % _Preset) % _Preset;
+    _Done_OSR = true;
+    refresh();
+  } else {
+    unsigned long pos = _Accumulator + elapsed;
+    if (pos >= _Preset) {  // finish this period, start the next
+      walk(_Preset - 1);
+      _Cursor = 0;
+      pos -= _Preset;
+      _Done_OSR = true;
+    }
+    _Accumulator = pos;
+    walk(pos);
+  }
+  return _Done_OSR;
+}
+
+bool PhaseEngineBase::reset() {
+  return (_Reset or !_Enable);
+}
+
+#ifdef MULTI_TIMER_EVENTS
+unsigned long PhaseEngineBase::timeToNextEvent() const {
+  if (_Done_OSR) return 0;  // period start one-shot clears next scan
+  if (_Reset or !_Enable) {
+    return (_TimerRunning or _States != 0) ? 0 : NO_EVENT;
+  }
+  if (!_TimerRunning) return 0;  // starts next scan
+
+  unsigned long t = _Preset - _Accumulator;  // next period start
+  if (_Cursor < _Switching) {
+    unsigned long edge = edgeAt(_Edges[_Cursor]) - _Accumulator;
+    if (edge < t) t = edge;
+  }
+  return t;
+}
+#endif
+
+void PhaseEngineBase::setChannel(uint8_t ch, unsigned long duty,
+                                 unsigned long phase) {
+  if (ch >= _Channels) return;
+  unsigned long bit = 1UL << ch;
+  PhaseChannel &c = _Chan[ch];
+
+  c.onAt = phase % _Preset;
+  if (duty == 0) {  // always off
+    c.offAt = c.onAt;
+    _FixedMask |= bit;
+  } else if (duty >= _Preset) {  // always on, OFF point never reached
+    c.offAt = c.onAt + _Preset;
+    _FixedMask |= bit;
+  } else {
+    c.offAt = (c.onAt + duty) % _Preset;
+    _FixedMask &= ~bit;
+  }
+  sortEdges();
+
+  // Only this channel's output is touched
+  if (_TimerRunning) {
+    if (channelOn(ch)) {
+      _States |= bit;
+    } else _States &= ~bit;
+  }
+  seek();
+}
+
+void PhaseEngineBase::setDuty(uint8_t ch, unsigned long duty) {
+  if (ch >= _Channels) return;
+  setChannel(ch, duty, _Chan[ch].onAt);
+}
+
+bool PhaseEngineBase::isOn(uint8_t ch) const {
+  if (ch >= _Channels) return false;
+  return (_States >> ch) & 1UL;
+}
+
+unsigned long PhaseEngineBase::getStates() const {
+  return _States;
+}
+// End of PhaseEngine